@@ -1566,7 +1566,8 @@ def export_(a, migrate_to_host, version, owner_supported=True):
 
         # JIT array -- requires extra transformations
         b = _dr.ravel(_dr.detach(a) if a.IsDiff else a)
-        _dr.eval(b)
+        if not b.is_evaluated_():
+            _dr.eval(b)
 
         if b.IsCUDA and migrate_to_host:
             if b is a:
@@ -1630,10 +1631,18 @@ def numpy(a):
     return arr
 
 
-def op_dlpack(a):
+def op_dlpack(a, stream=None):
     struct = a.export_(migrate_to_host=False, version=2)
     isize = a.Type.Size
     strides = tuple(k // isize for k in struct["strides"])
+
+    if stream is not None and stream != -1 and a.IsCUDA:
+        # The consumer enqueues work on its own CUDA stream. Dr.Jit cannot
+        # currently make its stream wait on an event, so conservatively
+        # synchronize before handing out the tensor ('stream=-1' means the
+        # consumer explicitly requested no synchronization)
+        _dr.sync_thread()
+
     return _dr.detail.to_dlpack(
         owner=struct["owner"],
         data=struct["data"][0],
@@ -1644,6 +1653,27 @@ def op_dlpack(a):
     )
 
 
+# Interned (device_type, device_id) tuples -- frameworks poll
+# __dlpack_device__ frequently, so avoid rebuilding the same tuple
+_dlpack_cpu_device = (1, 0)
+_dlpack_cuda_devices = {}
+
+
+def op_dlpack_device(a):
+    # (device_type, device_id) per the DLPack specification: kDLCPU=1,
+    # kDLCUDA=2. Unlike __dlpack__, this must not evaluate or copy the array
+    if a.IsCUDA:
+        device = _dr.device(a)
+        if device < 0:
+            device = 0
+        result = _dlpack_cuda_devices.get(device)
+        if result is None:
+            result = _dlpack_cuda_devices[device] = (2, device)
+        return result
+    else:
+        return _dlpack_cpu_device
+
+
 def torch(a):
     from torch.utils.dlpack import from_dlpack
     return from_dlpack(a.__dlpack__())
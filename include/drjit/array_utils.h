@@ -22,6 +22,10 @@
 
 #include <exception>
 
+#if defined(DRJIT_X86_SSE42)
+#  include <immintrin.h>
+#endif
+
 NAMESPACE_BEGIN(drjit)
 
 /// Reinterpret the binary represesentation of a data type
@@ -45,11 +49,22 @@ template <typename T> auto not_(const T &a) {
         return memcpy_cast<T>(~memcpy_cast<UInt>(a));
 }
 
+/* The bitwise operations below use SSE intrinsics for 'float' and 'double'
+   arguments when available. The memcpy-based fallback is semantically
+   equivalent but tends to bounce the value between vector and general
+   purpose registers. */
+
 template <typename T> auto or_(const T &a1, const T &a2) {
     using UInt = uint_array_t<T>;
 
     if constexpr (is_array_v<T> || std::is_integral_v<T>)
         return a1 | a2;
+#if defined(DRJIT_X86_SSE42)
+    else if constexpr (std::is_same_v<T, float>)
+        return _mm_cvtss_f32(_mm_or_ps(_mm_set_ss(a1), _mm_set_ss(a2)));
+    else if constexpr (std::is_same_v<T, double>)
+        return _mm_cvtsd_f64(_mm_or_pd(_mm_set_sd(a1), _mm_set_sd(a2)));
+#endif
     else
         return memcpy_cast<T>(memcpy_cast<UInt>(a1) | memcpy_cast<UInt>(a2));
 }
@@ -59,6 +74,12 @@ template <typename T> auto and_(const T &a1, const T &a2) {
 
     if constexpr (is_array_v<T> || std::is_integral_v<T>)
         return a1 & a2;
+#if defined(DRJIT_X86_SSE42)
+    else if constexpr (std::is_same_v<T, float>)
+        return _mm_cvtss_f32(_mm_and_ps(_mm_set_ss(a1), _mm_set_ss(a2)));
+    else if constexpr (std::is_same_v<T, double>)
+        return _mm_cvtsd_f64(_mm_and_pd(_mm_set_sd(a1), _mm_set_sd(a2)));
+#endif
     else
         return memcpy_cast<T>(memcpy_cast<UInt>(a1) & memcpy_cast<UInt>(a2));
 }
@@ -72,6 +93,12 @@ template <typename T> auto andnot_(const T &a1, const T &a2) {
         return a1 && !a2;
     else if constexpr (std::is_integral_v<T>)
         return a1 & ~a2;
+#if defined(DRJIT_X86_SSE42)
+    else if constexpr (std::is_same_v<T, float>)
+        return _mm_cvtss_f32(_mm_andnot_ps(_mm_set_ss(a2), _mm_set_ss(a1)));
+    else if constexpr (std::is_same_v<T, double>)
+        return _mm_cvtsd_f64(_mm_andnot_pd(_mm_set_sd(a2), _mm_set_sd(a1)));
+#endif
     else
         return memcpy_cast<T>(memcpy_cast<UInt>(a1) & ~memcpy_cast<UInt>(a2));
 }
@@ -81,6 +108,12 @@ template <typename T> auto xor_(const T &a1, const T &a2) {
 
     if constexpr (is_array_v<T> || std::is_integral_v<T>)
         return a1 ^ a2;
+#if defined(DRJIT_X86_SSE42)
+    else if constexpr (std::is_same_v<T, float>)
+        return _mm_cvtss_f32(_mm_xor_ps(_mm_set_ss(a1), _mm_set_ss(a2)));
+    else if constexpr (std::is_same_v<T, double>)
+        return _mm_cvtsd_f64(_mm_xor_pd(_mm_set_sd(a1), _mm_set_sd(a2)));
+#endif
     else
         return memcpy_cast<T>(memcpy_cast<UInt>(a1) ^ memcpy_cast<UInt>(a2));
 }
@@ -139,62 +172,149 @@ template <typename T> T abs_(const T &a) {
         return DRJIT_BUILTIN(fabsf)(a);
     else if constexpr (std::is_same_v<T, double>)
         return DRJIT_BUILTIN(fabs)(a);
-    else if constexpr (std::is_signed_v<T>)
-        return a < 0 ? -a : a;
-    else
+    else if constexpr (std::is_signed_v<T>) {
+        // Branchless: clear the sign via the xor/subtract identity
+        T m = T(a >> (sizeof(T) * 8 - 1));
+        return T((a ^ m) - m);
+    } else {
         return a;
+    }
 }
 
+/* On SSE4.1-capable targets, the functions below map directly to
+   sqrtss/roundss (resp. the sd variants). The libm builtins usually lower to
+   the same instructions, but some compilers emit a library call for
+   floor/ceil/trunc/rint -- the intrinsics guarantee a single instruction. */
+
 template <typename T> T sqrt_(const T &a) {
-    if constexpr (std::is_same_v<T, float>)
+    if constexpr (std::is_same_v<T, float>) {
+#if defined(DRJIT_X86_SSE42)
+        __m128 v = _mm_set_ss(a);
+        return _mm_cvtss_f32(_mm_sqrt_ss(v));
+#else
         return DRJIT_BUILTIN(sqrtf)(a);
-    else if constexpr (std::is_same_v<T, double>)
+#endif
+    } else if constexpr (std::is_same_v<T, double>) {
+#if defined(DRJIT_X86_SSE42)
+        __m128d v = _mm_set_sd(a);
+        return _mm_cvtsd_f64(_mm_sqrt_sd(v, v));
+#else
         return DRJIT_BUILTIN(sqrt)(a);
-    else
+#endif
+    } else {
         return (T) drjit::detail::sqrt_((float) a);
+    }
 }
 
 template <typename T> T floor_(const T &a) {
-    if constexpr (std::is_same_v<T, float>)
+    if constexpr (std::is_same_v<T, float>) {
+#if defined(DRJIT_X86_SSE42)
+        __m128 v = _mm_set_ss(a);
+        return _mm_cvtss_f32(
+            _mm_round_ss(v, v, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC));
+#else
         return DRJIT_BUILTIN(floorf)(a);
-    else if constexpr (std::is_same_v<T, double>)
+#endif
+    } else if constexpr (std::is_same_v<T, double>) {
+#if defined(DRJIT_X86_SSE42)
+        __m128d v = _mm_set_sd(a);
+        return _mm_cvtsd_f64(
+            _mm_round_sd(v, v, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC));
+#else
         return DRJIT_BUILTIN(floor)(a);
-    else
+#endif
+    } else {
         return (T) drjit::detail::floor_((float) a);
+    }
 }
 
 template <typename T> T ceil_(const T &a) {
-    if constexpr (std::is_same_v<T, float>)
+    if constexpr (std::is_same_v<T, float>) {
+#if defined(DRJIT_X86_SSE42)
+        __m128 v = _mm_set_ss(a);
+        return _mm_cvtss_f32(
+            _mm_round_ss(v, v, _MM_FROUND_TO_POS_INF | _MM_FROUND_NO_EXC));
+#else
         return DRJIT_BUILTIN(ceilf)(a);
-    else if constexpr (std::is_same_v<T, double>)
+#endif
+    } else if constexpr (std::is_same_v<T, double>) {
+#if defined(DRJIT_X86_SSE42)
+        __m128d v = _mm_set_sd(a);
+        return _mm_cvtsd_f64(
+            _mm_round_sd(v, v, _MM_FROUND_TO_POS_INF | _MM_FROUND_NO_EXC));
+#else
         return DRJIT_BUILTIN(ceil)(a);
-    else
+#endif
+    } else {
         return (T) drjit::detail::ceil_((float) a);
+    }
 }
 
 template <typename T> T trunc_(const T &a) {
-    if constexpr (std::is_same_v<T, float>)
+    if constexpr (std::is_same_v<T, float>) {
+#if defined(DRJIT_X86_SSE42)
+        __m128 v = _mm_set_ss(a);
+        return _mm_cvtss_f32(
+            _mm_round_ss(v, v, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC));
+#else
         return DRJIT_BUILTIN(truncf)(a);
-    else if constexpr (std::is_same_v<T, double>)
+#endif
+    } else if constexpr (std::is_same_v<T, double>) {
+#if defined(DRJIT_X86_SSE42)
+        __m128d v = _mm_set_sd(a);
+        return _mm_cvtsd_f64(
+            _mm_round_sd(v, v, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC));
+#else
         return DRJIT_BUILTIN(trunc)(a);
-    else
+#endif
+    } else {
         return (T) drjit::detail::trunc_((float) a);
+    }
 }
 
 template <typename T> T round_(const T &a) {
-    if constexpr (std::is_same_v<T, float>)
+    if constexpr (std::is_same_v<T, float>) {
+#if defined(DRJIT_X86_SSE42)
+        __m128 v = _mm_set_ss(a);
+        return _mm_cvtss_f32(
+            _mm_round_ss(v, v, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC));
+#else
         return DRJIT_BUILTIN(rintf)(a);
-    else if constexpr (std::is_same_v<T, double>)
+#endif
+    } else if constexpr (std::is_same_v<T, double>) {
+#if defined(DRJIT_X86_SSE42)
+        __m128d v = _mm_set_sd(a);
+        return _mm_cvtsd_f64(
+            _mm_round_sd(v, v, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC));
+#else
         return DRJIT_BUILTIN(rint)(a);
-    else
+#endif
+    } else {
         return (T) drjit::detail::round_((float) a);
+    }
 }
 
 template <typename T> T maximum_(const T &a, const T &b) {
+#if defined(DRJIT_X86_SSE42)
+    /* Single maxss/maxsd instruction; the operand order reproduces the
+       NaN behavior of the expression below (unordered -> 'a') */
+    if constexpr (std::is_same_v<T, float>)
+        return _mm_cvtss_f32(_mm_max_ss(_mm_set_ss(b), _mm_set_ss(a)));
+    else if constexpr (std::is_same_v<T, double>)
+        return _mm_cvtsd_f64(_mm_max_sd(_mm_set_sd(b), _mm_set_sd(a)));
+    else
+#endif
     return a < b ? b : a;
 }
 
 template <typename T> T minimum_(const T &a, const T &b) {
+#if defined(DRJIT_X86_SSE42)
+    if constexpr (std::is_same_v<T, float>)
+        return _mm_cvtss_f32(_mm_min_ss(_mm_set_ss(b), _mm_set_ss(a)));
+    else if constexpr (std::is_same_v<T, double>)
+        return _mm_cvtsd_f64(_mm_min_sd(_mm_set_sd(b), _mm_set_sd(a)));
+    else
+#endif
     return b < a ? b : a;
 }
 
@@ -324,14 +444,38 @@ NAMESPACE_END(detail)
 
 class Exception : public std::exception {
 public:
-    Exception(const char* msg) : m_msg(DRJIT_STRDUP(msg)) { }
-    Exception(const Exception& e) : m_msg(DRJIT_STRDUP(e.m_msg)) { }
-    Exception(Exception&& e) : m_msg(e.m_msg) { e.m_msg = nullptr; }
+    Exception(const char* msg) { set_message(msg); }
+    Exception(const Exception& e) { set_message(e.m_msg); }
+    Exception(Exception&& e) {
+        if (e.m_msg == e.m_inline) {
+            memcpy(m_inline, e.m_inline, sizeof(m_inline));
+            m_msg = m_inline;
+        } else {
+            m_msg = e.m_msg;
+            e.m_msg = e.m_inline;
+            e.m_inline[0] = '\0';
+        }
+    }
     Exception& operator=(const Exception&) = delete;
     Exception& operator=(Exception&&) = delete;
     virtual const char* what() const noexcept { return m_msg; }
-    virtual ~Exception() { free(m_msg); }
+    virtual ~Exception() {
+        if (m_msg != m_inline)
+            free(m_msg);
+    }
 private:
+    /* Messages up to 256 bytes (i.e. everything produced by drjit_raise())
+       are stored inline, longer ones on the heap */
+    void set_message(const char *msg) {
+        size_t size = strlen(msg) + 1;
+        if (size <= sizeof(m_inline)) {
+            memcpy(m_inline, msg, size);
+            m_msg = m_inline;
+        } else {
+            m_msg = DRJIT_STRDUP(msg);
+        }
+    }
+    char m_inline[256];
     char *m_msg;
 };
 
@@ -339,20 +483,27 @@ private:
 #endif
 
 #if !defined(_MSC_VER)
-__attribute__((noreturn,noinline))
+__attribute__((noreturn,noinline,format(printf,1,2)))
 #else
 __declspec(noreturn,noinline)
 #endif
 inline void drjit_raise(const char *fmt, ...) {
     char msg[256];
-    va_list args;
-    va_start(args, fmt);
-    vsnprintf(msg, sizeof(msg), fmt, args);
-    va_end(args);
+    const char *what = fmt;
+
+    // Skip the costly printf machinery for messages without format arguments
+    if (strchr(fmt, '%')) {
+        va_list args;
+        va_start(args, fmt);
+        vsnprintf(msg, sizeof(msg), fmt, args);
+        va_end(args);
+        what = msg;
+    }
+
 #if defined(__cpp_exceptions)
-    throw drjit::Exception(msg);
+    throw drjit::Exception(what);
 #else
-    fprintf(stderr, "%s\n", msg);
+    fprintf(stderr, "%s\n", what);
     abort();
 #endif
 }
@@ -1726,7 +1726,7 @@ struct DiffArray : ArrayBase<value_t<Type_>, is_mask_v<Type_>, DiffArray<Type_>>
             DRJIT_MARK_USED(offset);
 #if !defined(NDEBUG) && !defined(DRJIT_DISABLE_RANGE_CHECK)
             if (offset != 0)
-                drjit_raise("Out of range access (tried to access index %u in "
+                drjit_raise("Out of range access (tried to access index %zu in "
                             "an array of size 1)", offset);
 #endif
             m_value = value;
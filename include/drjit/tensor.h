@@ -138,7 +138,7 @@ struct Tensor
         size_t size = m_array.size();
         if (size != 0 && size != 1)
             drjit_raise("Tensor(): initialization with a non-trivial array "
-                        "(size %u) requires specifying the 'shape' parameter.", size);
+                        "(size %zu) requires specifying the 'shape' parameter.", size);
     }
 
     Tensor(const Array &data, size_t ndim, const size_t *shape)
@@ -77,6 +77,20 @@ Mask extract_mask(const T &v, const Ts &... vs) {
         return true;
 }
 
+/// Does the argument list end with a mask? If not, extract_mask() above is
+/// known to return a trivial 'true' at compile time
+template <typename... Ts> struct vcall_mask_arg {
+    static constexpr bool value = false;
+};
+template <typename T> struct vcall_mask_arg<T> {
+    static constexpr bool value = is_mask_v<T> || is_pair_with_mask_v<T>;
+};
+template <typename T0, typename T1, typename... Ts>
+struct vcall_mask_arg<T0, T1, Ts...> : vcall_mask_arg<T1, Ts...> { };
+
+template <typename... Ts>
+constexpr bool has_mask_arg_v = vcall_mask_arg<Ts...>::value;
+
 template <size_t I, size_t N, typename T>
 decltype(auto) set_mask_true(const T &v) {
     if constexpr (is_mask_v<T> && I == N - 1)
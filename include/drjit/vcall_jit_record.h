@@ -14,15 +14,147 @@
 
 #include <drjit-core/containers.h>
 #include <drjit-core/state.h>
+#include <cstdlib>
+#include <cstring>
 
 NAMESPACE_BEGIN(drjit)
 NAMESPACE_BEGIN(detail)
 
-template <typename T>
-void collect_indices(dr_index_vector &indices, const T &value) {
+#if defined(DRJIT_VCALL_DEBUG)
+/// Runtime switch for the per-instance kernel annotations, so that debug
+/// builds only pay for tracing when it was actually requested
+inline bool vcall_debug_trace() {
+    static const bool value = getenv("DRJIT_VCALL_TRACE") != nullptr;
+    return value;
+}
+#endif
+
+/* The vectors filled while recording a virtual function call hold one entry
+   per instance or per JIT variable of the call signature -- typically a few
+   dozen elements at most, yet 'dr_vector' heap-allocates and regrows them on
+   every invocation. The following variant reserves ahead of time and keeps
+   up to 'Small' entries in inline storage (only trivial 'T' is supported) */
+template <typename T, size_t Small> struct dr_small_vector {
+    dr_small_vector() = default;
+    dr_small_vector(size_t size, const T &value) {
+        reserve(size);
+        for (size_t i = 0; i < size; ++i)
+            m_data[i] = value;
+        m_size = size;
+    }
+    dr_small_vector(const dr_small_vector &) = delete;
+    dr_small_vector &operator=(const dr_small_vector &) = delete;
+    ~dr_small_vector() {
+        if (m_data != m_local)
+            free(m_data);
+    }
+
+    void reserve(size_t capacity) {
+        if (capacity <= m_capacity)
+            return;
+        T *data = (T *) malloc(capacity * sizeof(T));
+        memcpy(data, m_data, m_size * sizeof(T));
+        if (m_data != m_local)
+            free(m_data);
+        m_data = data;
+        m_capacity = capacity;
+    }
+
+    void push_back(const T &value) {
+        if (m_size == m_capacity)
+            reserve(m_capacity * 2);
+        m_data[m_size++] = value;
+    }
+
+    size_t size() const { return m_size; }
+    T *data() { return m_data; }
+    const T *data() const { return m_data; }
+    bool empty() const { return m_size == 0; }
+    T &operator[](size_t i) { return m_data[i]; }
+    const T &operator[](size_t i) const { return m_data[i]; }
+
+    T m_local[Small];
+    T *m_data = m_local;
+    size_t m_size = 0, m_capacity = Small;
+};
+
+/// Variant of the above that holds references to JIT variables
+template <size_t Small>
+struct dr_small_index_vector : dr_small_vector<uint32_t, Small> {
+    using Base = dr_small_vector<uint32_t, Small>;
+
+    dr_small_index_vector() = default;
+    ~dr_small_index_vector() {
+        for (size_t i = 0; i < Base::m_size; ++i)
+            jit_var_dec_ref(Base::m_data[i]);
+    }
+
+    void push_back(uint32_t index) {
+        jit_var_inc_ref(index);
+        Base::push_back(index);
+    }
+};
+
+/// Number of JIT variable indices in 'T' when known at compile time,
+/// or 'Dynamic' when the count depends on runtime state
+template <typename T> constexpr size_t jit_index_count() {
     if constexpr (array_depth_v<T> > 1) {
-        for (size_t i = 0; i < value.derived().size(); ++i)
-            collect_indices(indices, value.derived().entry(i));
+        constexpr size_t inner = jit_index_count<value_t<T>>();
+        if constexpr (array_size_v<T> == Dynamic || inner == Dynamic)
+            return Dynamic;
+        else
+            return array_size_v<T> * inner;
+    } else if constexpr (is_diff_v<T>) {
+        return jit_index_count<detached_t<T>>();
+    } else if constexpr (is_jit_v<T>) {
+        return 1;
+    } else if constexpr (is_drjit_struct_v<T>) {
+        return Dynamic;
+    } else {
+        return 0;
+    }
+}
+
+/// Sum of jit_index_count() over a parameter pack, with 'Dynamic' absorbing
+template <typename... Ts> constexpr size_t jit_index_count_sum() {
+    size_t counts[] = { jit_index_count<Ts>()..., 0 }, result = 0;
+    for (size_t count : counts) {
+        if (count == Dynamic)
+            return Dynamic;
+        result += count;
+    }
+    return result;
+}
+
+template <typename Vector, typename T>
+void collect_indices(Vector &indices, const T &value);
+template <typename Vector, typename T>
+void write_indices(Vector &indices, T &value, uint32_t &offset);
+
+/* Turn the traversal of statically sized arrays into a straight-line
+   sequence of calls instead of a loop with a runtime trip count */
+template <typename Vector, typename T, size_t... Is>
+DRJIT_INLINE void collect_indices_static(Vector &indices, const T &value,
+                                         std::index_sequence<Is...>) {
+    (collect_indices(indices, value.derived().entry(Is)), ...);
+}
+
+template <typename Vector, typename T, size_t... Is>
+DRJIT_INLINE void write_indices_static(Vector &indices, T &value,
+                                       uint32_t &offset,
+                                       std::index_sequence<Is...>) {
+    (write_indices(indices, value.derived().entry(Is), offset), ...);
+}
+
+template <typename Vector, typename T>
+void collect_indices(Vector &indices, const T &value) {
+    if constexpr (array_depth_v<T> > 1) {
+        if constexpr (array_size_v<T> != Dynamic)
+            collect_indices_static(indices, value,
+                std::make_index_sequence<array_size_v<T>>());
+        else
+            for (size_t i = 0; i < value.derived().size(); ++i)
+                collect_indices(indices, value.derived().entry(i));
     } else if constexpr (is_diff_v<T>) {
         collect_indices(indices, value.detach_());
     } else if constexpr (is_jit_v<T>) {
@@ -38,11 +170,15 @@ void collect_indices(dr_index_vector &indices, const T &value) {
     }
 }
 
-template <typename T>
-void write_indices(dr_vector<uint32_t> &indices, T &value, uint32_t &offset) {
+template <typename Vector, typename T>
+void write_indices(Vector &indices, T &value, uint32_t &offset) {
     if constexpr (array_depth_v<T> > 1) {
-        for (size_t i = 0; i < value.derived().size(); ++i)
-            write_indices(indices, value.derived().entry(i), offset);
+        if constexpr (array_size_v<T> != Dynamic)
+            write_indices_static(indices, value, offset,
+                std::make_index_sequence<array_size_v<T>>());
+        else
+            for (size_t i = 0; i < value.derived().size(); ++i)
+                write_indices(indices, value.derived().entry(i), offset);
     } else if constexpr (is_diff_v<T>) {
         write_indices(indices, value.detach_(), offset);
     } else if constexpr (is_jit_v<T>) {
@@ -78,7 +214,9 @@ template <typename T> DRJIT_INLINE auto wrap_vcall(const T &value) {
 
 template <typename Result, typename Base, typename Func, typename Self,
           typename Mask, size_t... Is, typename... Args>
-Result vcall_jit_record_impl(const char *name, uint32_t n_inst,
+Result vcall_jit_record_impl(const char *name,
+                             const dr_small_vector<uint32_t, 16> &inst_id,
+                             const dr_small_vector<void *, 16> &inst_ptr,
                              const Func &func, const Self &self,
                              const Mask &mask, std::index_sequence<Is...>,
                              const Args &... args) {
@@ -86,43 +224,98 @@ Result vcall_jit_record_impl(const char *name, uint32_t n_inst,
     constexpr size_t N = sizeof...(Args);
     DRJIT_MARK_USED(N);
 
-    uint32_t scope = jit_scope(Backend);
+    uint32_t scope = jit_scope(Backend),
+             n_inst = (uint32_t) inst_id.size();
 
-    char label[128];
+    /* 'Base::Domain' and 'name' are fixed for any given instantiation of
+       this function template -- format the labels derived from them once on
+       the first call and reuse them afterwards */
+    struct LabelCache {
+        char call[128];
+#if defined(DRJIT_VCALL_DEBUG)
+        char prefix[128];
+        size_t prefix_len;
+#endif
+        LabelCache(const char *domain, const char *name) {
+            snprintf(call, sizeof(call), "%s::%s()", domain, name);
+#if defined(DRJIT_VCALL_DEBUG)
+            prefix_len = (size_t) snprintf(prefix, sizeof(prefix),
+                                           "VCall: %s::%s() [instance ",
+                                           domain, name);
+            if (prefix_len > sizeof(prefix) - 13)
+                prefix_len = sizeof(prefix) - 13;
+#endif
+        }
+    };
+    static const LabelCache labels(Base::Domain, name);
+
+    dr_small_index_vector<32> indices_in, indices_out_all;
+    dr_small_vector<uint32_t, 16> state(n_inst + 1, 0);
 
-    dr_index_vector indices_in, indices_out_all;
-    dr_vector<uint32_t> state(n_inst + 1, 0);
-    dr_vector<uint32_t> inst_id(n_inst, 0);
+    /* When the number of JIT variables among the inputs/outputs is known at
+       compile time, size the index vectors up front; otherwise, extrapolate
+       from the first recorded instance (all instances produce identically
+       shaped output). This avoids repeated regrowth, which would copy the
+       vectors and perform a reference counting operation per element. */
+    constexpr size_t n_in = jit_index_count_sum<Args...>(),
+                     n_out = jit_index_count<Result>();
+
+    if constexpr (n_in != Dynamic)
+        indices_in.reserve(n_in);
+    if constexpr (n_out != Dynamic)
+        indices_out_all.reserve(n_out * n_inst);
 
     (collect_indices(indices_in, args), ...);
 
     detail::JitState<Backend> jit_state;
-    snprintf(label, sizeof(label), "%s::%s", Base::Domain, name);
 
     if (!jit_state.begin_recording(name))
         return zeros<Result>();
 
+#if defined(DRJIT_VCALL_DEBUG)
+    /* Only the trailing instance number of the per-instance label changes
+       between loop iterations -- copy the cached shared portion once */
+    char label[128];
+    size_t label_prefix = 0;
+    if (vcall_debug_trace()) {
+        label_prefix = labels.prefix_len;
+        memcpy(label, labels.prefix, label_prefix);
+    }
+#endif
+
     state[0] = jit_record_checkpoint(Backend);
 
-    uint32_t n_inst_max = jit_registry_get_max(Backend, Base::Domain);
-    for (uint32_t i = 1, j = 1; i <= n_inst_max; ++i) {
-        snprintf(label, sizeof(label), "VCall: %s::%s() [instance %u]",
-                 Base::Domain, name, j);
+    /* The special mask variable routing the call mask into the recorded
+       functions is the same for every instance -- create it once and re-push
+       it for each one instead of allocating n_inst copies */
+    Mask vcall_mask = true;
+    if constexpr (Backend == JitBackend::LLVM) {
+        jit_set_scope(Backend, scope);
+        vcall_mask = Mask::steal(jit_var_vcall_mask(Backend));
+    }
 
-        Base *base = (Base *) jit_registry_get_ptr(Backend, Base::Domain, i);
-        if (!base)
-            continue;
+    for (uint32_t j = 0; j < n_inst; ++j) {
+        Base *base = (Base *) inst_ptr[j];
 
         jit_set_scope(Backend, scope);
 
 #if defined(DRJIT_VCALL_DEBUG)
-        jit_state.set_prefix(label);
+        if (vcall_debug_trace()) {
+            char *p = label + label_prefix, digits[10];
+            uint32_t value = j + 1;
+            int n_digits = 0;
+            do {
+                digits[n_digits++] = (char) ('0' + value % 10);
+                value /= 10;
+            } while (value);
+            while (n_digits)
+                *p++ = digits[--n_digits];
+            *p++ = ']';
+            *p = '\0';
+            jit_state.set_prefix(label);
+        }
 #endif
-        jit_state.set_self(i);
-
-        Mask vcall_mask = true;
-        if constexpr (Backend == JitBackend::LLVM)
-            vcall_mask = Mask::steal(jit_var_vcall_mask(Backend));
+        jit_state.set_self(inst_id[j]);
         jit_state.set_mask(vcall_mask.index());
 
         if constexpr (std::is_same_v<Result, std::nullptr_t>) {
@@ -131,25 +324,30 @@ Result vcall_jit_record_impl(const char *name, uint32_t n_inst,
             // The following assignment converts scalar return values
             Result tmp = func(base, set_mask_true<Is, N>(args)...);
             collect_indices(indices_out_all, tmp);
+
+            if constexpr (n_out == Dynamic) {
+                if (j == 0)
+                    indices_out_all.reserve(indices_out_all.size() * n_inst);
+            }
         }
 
         jit_state.clear_mask();
 
 #if defined(DRJIT_VCALL_DEBUG)
-        jit_state.clear_prefix();
+        if (vcall_debug_trace())
+            jit_state.clear_prefix();
 #endif
 
-        state[j] = jit_record_checkpoint(Backend);
-        inst_id[j - 1] = i;
-        j++;
+        state[j + 1] = jit_record_checkpoint(Backend);
     }
 
-    dr_vector<uint32_t> indices_out((uint32_t) indices_out_all.size() / n_inst, 0);
-
-    snprintf(label, sizeof(label), "%s::%s()", Base::Domain, name);
+    /* Every instance contributes the same number of output indices; use the
+       compile-time count when available rather than dividing */
+    dr_small_vector<uint32_t, 32> indices_out(
+        n_out != Dynamic ? n_out : indices_out_all.size() / n_inst, 0);
 
     uint32_t se = jit_var_vcall(
-        label, self.index(), mask.index(), n_inst, inst_id.data(),
+        labels.call, self.index(), mask.index(), n_inst, inst_id.data(),
         (uint32_t) indices_in.size(), indices_in.data(),
         (uint32_t) indices_out_all.size(), indices_out_all.data(), state.data(),
         indices_out.data());
@@ -182,6 +380,12 @@ vcall_jit_record_impl_scalar(Base *inst, const Func &func, const Mask &mask,
     jit_state.set_mask(mask.index());
 
     if constexpr (is_drjit_struct_v<Result> || is_array_v<Result>) {
+        /* When the mask is known to be all-true (e.g. an unmasked call via a
+           literal 'self' pointer), no lanes need zeroing -- skip the select,
+           which would otherwise create a JIT node per output variable */
+        if (mask.is_literal() && mask[0] == true)
+            return func(inst, (set_mask_true<Is, N>(args))...);
+
         // Return zero for masked results
         return select(mask, func(inst, (set_mask_true<Is, N>(args))...),
                       zeros<Result>());
@@ -206,6 +410,23 @@ inline std::pair<void *, uint32_t> vcall_registry_get(JitBackend Backend,
     return { inst, n_inst };
 }
 
+/// Build a dense list of the live instances in the given registry domain.
+/// The registry may be sparsely populated after instance destruction, in
+/// which case walking it repeatedly is wasteful -- do so only once per call.
+inline void vcall_registry_list(JitBackend Backend, const char *domain,
+                                dr_small_vector<uint32_t, 16> &inst_id,
+                                dr_small_vector<void *, 16> &inst_ptr) {
+    uint32_t n = jit_registry_get_max(Backend, domain);
+
+    for (uint32_t i = 1; i <= n; ++i) {
+        void *ptr = jit_registry_get_ptr(Backend, domain, i);
+        if (ptr) {
+            inst_id.push_back(i);
+            inst_ptr.push_back(ptr);
+        }
+    }
+}
+
 template <typename Result, typename Func, typename Self, typename... Args>
 Result vcall_jit_record(const char *name, const Func &func, Self &self,
                         const Args &... args) {
@@ -214,33 +435,43 @@ Result vcall_jit_record(const char *name, const Func &func, Self &self,
     static constexpr JitBackend Backend = detached_t<Self>::Backend;
     using Mask = mask_t<Self>;
 
-    auto [inst, n_inst] = vcall_registry_get(Backend, Base::Domain);
+    dr_small_vector<uint32_t, 16> inst_id;
+    dr_small_vector<void *, 16> inst_ptr;
+    vcall_registry_list(Backend, Base::Domain, inst_id, inst_ptr);
+    uint32_t n_inst = (uint32_t) inst_id.size();
 
     size_t self_size = width(self, args...);
-    Mask mask = extract_mask<Mask>(args...);
-    bool masked = mask.is_literal() && mask[0] == false,
-         vcall_inline = jit_flag(JitFlag::VCallInline);
 
-    if (n_inst == 0 || self_size == 0 || masked) {
+    /* Handle the trivial cases that do not depend on the call mask before
+       extracting it, so that they perform no work on the argument pack */
+    if (n_inst == 0 || self_size == 0) {
         jit_log(::LogLevel::InfoSym,
                 "jit_var_vcall(self=r%u): call (\"%s::%s()\") not performed (%s)",
                 self.index(), Base::Domain, name,
-                n_inst == 0 ? "no instances"
-                            : (masked ? "masked" : "self.size == 0"));
+                n_inst == 0 ? "no instances" : "self.size == 0");
+        return zeros<Result>(self_size);
+    }
+
+    Mask mask = extract_mask<Mask>(args...);
+
+    if (has_mask_arg_v<Args...> && mask.is_literal() && mask[0] == false) {
+        jit_log(::LogLevel::InfoSym,
+                "jit_var_vcall(self=r%u): call (\"%s::%s()\") not performed "
+                "(masked)", self.index(), Base::Domain, name);
         return zeros<Result>(self_size);
-    } else if (n_inst == 1 && vcall_inline) {
+    } else if (n_inst == 1 && jit_flag(JitFlag::VCallInline)) {
         jit_log(::LogLevel::InfoSym,
                 "jit_var_vcall(self=r%u): call (\"%s::%s()\") inlined (only 1 "
                 "instance exists.)", self.index(), Base::Domain, name);
         return vcall_jit_record_impl_scalar<Result, Base>(
-            (Base *) inst, func, mask && neq(self, nullptr),
+            (Base *) inst_ptr[0], func, mask && neq(self, nullptr),
             std::make_index_sequence<sizeof...(Args)>(), args...);
     } else {
         isolate_grad<DiffType> guard;
         jit_new_scope(Backend);
 
         return vcall_jit_record_impl<Result, Base>(
-            name, n_inst, func, self, mask,
+            name, inst_id, inst_ptr, func, self, mask,
             std::make_index_sequence<sizeof...(Args)>(),
             wrap_vcall(args)...);
     }
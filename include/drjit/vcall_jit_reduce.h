@@ -12,6 +12,8 @@
 
 #pragma once
 
+#include <algorithm>
+
 NAMESPACE_BEGIN(drjit)
 NAMESPACE_BEGIN(detail)
 
@@ -21,6 +23,9 @@ DRJIT_INLINE decltype(auto) gather_helper(const T& value, const UInt32 &perm) {
     if constexpr (is_mask_v<T> && I == N - 1) {
         return true;
     } else if constexpr (is_jit_v<T>) {
+        // Gathering from a size-1 array is equivalent to a broadcast
+        if (value.size() == 1)
+            return T(value);
         return gather<T, true>(value, perm);
     } else if constexpr (is_drjit_struct_v<T>) {
         T result = value;
@@ -58,47 +63,95 @@ Result vcall_jit_reduce_impl(Func func, const Self &self_,
     Mask mask = extract_mask<Mask>(args...);
     size_t mask_size = mask.size();
 
-    // Apply mask stack
-    mask = Mask::steal(jit_var_mask_apply(mask.index(),
-        (uint32_t) (self_size > mask_size ? self_size : mask_size)
-    ));
-
-    struct SetSelfHelper {
-        void set(uint32_t value, uint32_t index) {
-            jit_vcall_set_self(detached_t<Mask>::Backend, value, index);
-        }
+    /* When the mask is trivially true and no mask is currently active, the
+       mask stack lookup and the 'self_ & mask' operation below are no-ops
+       that would still create JIT variables -- skip both in that case. The
+       absence of a mask argument already settles the first half of this
+       condition at compile time. */
+    bool trivial_mask = !has_mask_arg_v<Args...> ||
+                        (mask.is_literal() && mask[0] == true);
+    if (trivial_mask) {
+        // jit_var_mask_peek() returns an owning reference
+        Mask mask_top = Mask::steal(jit_var_mask_peek(Backend));
+        trivial_mask = mask_top.index() == 0;
+    }
 
-        ~SetSelfHelper() {
-            jit_vcall_set_self(detached_t<Mask>::Backend, 0, 0);
+    // Apply mask stack
+    if (!trivial_mask)
+        mask = Mask::steal(jit_var_mask_apply(mask.index(),
+            (uint32_t) (self_size > mask_size ? self_size : mask_size)
+        ));
+
+    // Guard that resets the 'self' pointer on scope exit if it was ever set
+    struct SetSelfGuard {
+        bool armed = false;
+        ~SetSelfGuard() {
+            if (armed)
+                jit_vcall_set_self(Backend, 0, 0);
         }
     };
 
-    Self self = self_ & mask;
+    Self self = trivial_mask ? self_ : self_ & mask;
     auto [buckets, n_inst] = self.vcall_();
 
     Result result;
-    SetSelfHelper self_helper;
+    SetSelfGuard self_guard;
     if (n_inst > 0 && self_size > 0) {
         result = empty<Result>(self_size);
-        size_t last_size = 0;
-
-        for (size_t i = 0; i < n_inst ; ++i) {
+        size_t last_size = 0, last_launch_size = 0;
+        Mask default_mask;
+
+        /* Process buckets in order of decreasing wavefront size so that
+           equal sizes end up adjacent, which maximizes reuse of the default
+           mask and the launch merging enabled by the heuristic below */
+        dr_vector<size_t> bucket_size(n_inst, 0);
+        dr_vector<uint32_t> order(n_inst, 0);
+        for (size_t i = 0; i < n_inst; ++i) {
+            bucket_size[i] = jit_var_size(buckets[i].index);
+            order[i] = (uint32_t) i;
+        }
+        std::stable_sort(order.data(), order.data() + n_inst,
+                         [&bucket_size](uint32_t i0, uint32_t i1) {
+                             return bucket_size[i0] > bucket_size[i1];
+                         });
+
+        // Zero element shared by all null buckets, created on first use
+        Result zero_value;
+        bool zero_valid = false;
+        DRJIT_MARK_USED(zero_value);
+        DRJIT_MARK_USED(zero_valid);
+
+        for (size_t k = 0; k < n_inst ; ++k) {
+            size_t i = order[k];
             UInt32 perm = UInt32::borrow(buckets[i].index);
-            size_t wavefront_size = perm.size();
+            size_t wavefront_size = bucket_size[i];
 
-            MaskScope<Mask> scope(Mask::steal(
-                jit_var_mask_default(Backend, (uint32_t) wavefront_size)));
+            if (wavefront_size != last_size) {
+                // The default mask only depends on the wavefront size; reuse
+                // it while consecutive buckets share the same size
+                default_mask = Mask::steal(
+                    jit_var_mask_default(Backend, (uint32_t) wavefront_size));
+                last_size = wavefront_size;
+            }
 
-            UInt32 instance_id = gather<UInt32>(self, perm);
+            /* Avoid merging multiple vcall launches if size repeats. Null
+               buckets only scatter zeros, which may merge freely -- they
+               neither force an evaluation nor count as a launch. */
+            if (buckets[i].ptr) {
+                if (wavefront_size == last_launch_size)
+                    eval(result);
+                last_launch_size = wavefront_size;
+            }
 
-            // Avoid merging multiple vcall launches if size repeats..
-            if (wavefront_size != last_size)
-                last_size = wavefront_size;
-            else
-                eval(result);
+            MaskScope<Mask> scope(default_mask);
 
             if (buckets[i].ptr) {
-                self_helper.set(buckets[i].id, instance_id.index());
+                // All lanes of a bucket refer to the same instance, so the
+                // instance ID is already known on the host -- broadcast it
+                // instead of gathering it from 'self'
+                UInt32 instance_id = full<UInt32>(buckets[i].id, wavefront_size);
+                jit_vcall_set_self(Backend, buckets[i].id, instance_id.index());
+                self_guard.armed = true;
 
                 if constexpr (!std::is_same_v<Result, std::nullptr_t>) {
                     using OrigResult = decltype(func((Class) nullptr, args...));
@@ -112,8 +165,13 @@ Result vcall_jit_reduce_impl(Func func, const Self &self_,
                     func((Class) buckets[i].ptr, gather_helper<Is, N>(args, perm)...);
                 }
             } else {
-                if constexpr (!std::is_same_v<Result, std::nullptr_t>)
-                    scatter<true>(result, zeros<Result>(), perm);
+                if constexpr (!std::is_same_v<Result, std::nullptr_t>) {
+                    if (!zero_valid) {
+                        zero_value = zeros<Result>();
+                        zero_valid = true;
+                    }
+                    scatter<true>(result, zero_value, perm);
+                }
             }
         }
         schedule(result);
@@ -1,5 +1,6 @@
 #include "common.h"
 #include <pybind11/functional.h>
+#include <array>
 
 struct DLManagedTensor {
     void *data;
@@ -19,21 +20,21 @@ static_assert(sizeof(DLManagedTensor) == 64, "Alignment issue?");
 
 static void cleanup(DLManagedTensor *mt) {
     py::gil_scoped_acquire acquire;
-    delete[] mt->shape;
-    delete[] mt->strides;
+    delete[] mt->shape; // single allocation that also holds 'strides'
     Py_DECREF(mt->manager_ctx);
     delete mt;
 }
 
-static int64_t *convert_tuple(const py::tuple &t) {
-    size_t size = t.size();
-    if (size == 0)
-        return nullptr;
-
-    std::unique_ptr<int64_t[]> result(new int64_t[size]);
-    for (size_t i = 0; i < t.size(); ++i)
-        result[i] = py::cast<int64_t>(t[i]);
-    return result.release();
+static void convert_tuple(const py::tuple &t, int64_t *out) {
+    /* The entries are plain Python integers computed on the caller side --
+       read them through the C API instead of a py::cast per element */
+    for (size_t i = 0; i < t.size(); ++i) {
+        int64_t value = (int64_t) PyLong_AsLongLong(
+            PyTuple_GET_ITEM(t.ptr(), (py::ssize_t) i));
+        if (value == -1 && PyErr_Occurred())
+            throw py::error_already_set();
+        out[i] = value;
+    }
 }
 
 static py::object convert_tuple(int64_t *index, int ndim) {
@@ -59,8 +60,17 @@ static int convert_dtype(VarType type) {
 }
 
 static VarType convert_dtype(int dtype) {
+    /* Precompute the forward mapping once so that the reverse lookup scans
+       a small integer array instead of re-encoding every type each call */
+    static const std::array<int, (size_t) VarType::Count> lut = [] {
+        std::array<int, (size_t) VarType::Count> result;
+        for (int i = 0; i < (int) VarType::Count; ++i)
+            result[i] = convert_dtype((VarType) i);
+        return result;
+    }();
+
     for (int i = 0; i < (int) VarType::Count; ++i) {
-        if (convert_dtype((VarType) i) == dtype)
+        if (lut[i] == dtype)
             return (VarType) i;
     }
 
@@ -70,18 +80,36 @@ static VarType convert_dtype(int dtype) {
 py::capsule to_dlpack(const py::object &owner, uint64_t data, VarType type,
                       int device, const py::tuple &shape,
                       const py::tuple &strides) {
+    size_t ndim = shape.size(), n_strides = strides.size();
+
+    // An empty stride tuple denotes a contiguous ('strides = NULL') tensor
+    if (n_strides != 0 && n_strides != ndim)
+        throw std::runtime_error("to_dlpack(): the 'strides' tuple must be "
+                                 "empty or match the length of 'shape'!");
+
+    /* Allocate the shape and stride arrays as a single block so that each
+       export performs (and each release frees) one allocation, not two */
+    std::unique_ptr<int64_t[]> buf;
+    if (ndim > 0) {
+        buf.reset(new int64_t[ndim * 2]);
+        convert_tuple(shape, buf.get());
+        if (n_strides > 0)
+            convert_tuple(strides, buf.get() + ndim);
+    }
+
     DLManagedTensor* t = new DLManagedTensor();
     t->data = (void *) data;
-    t->ndim = (int) shape.size();
+    t->ndim = (int) ndim;
     t->device_type = device == -1 ? 1 : 2;
     t->device_id = device == -1 ? 0 : device;
-    t->shape = convert_tuple(shape);
-    t->strides = convert_tuple(strides);
+    t->shape = buf.get();
+    t->strides = (ndim > 0 && n_strides > 0) ? buf.get() + ndim : nullptr;
     t->dtype = convert_dtype(type);
     t->byte_offset = 0;
     t->deleter = cleanup;
     t->manager_ctx = owner.ptr();
     Py_INCREF(t->manager_ctx);
+    buf.release(); // now owned by 't'
 
     py::capsule capsule(t, "dltensor", [](PyObject *o) {
         DLManagedTensor *mt = reinterpret_cast<DLManagedTensor *>(
@@ -28,6 +28,18 @@ def test_roundtrip_dlpack_all(package):
     assert a1 == a3
     assert a1.x == Float(a1.x.__dlpack__())
 
+    # The device query must not evaluate the array, and repeated calls
+    # return the interned tuple
+    device = a1.x.__dlpack_device__()
+    if a1.x.IsCUDA:
+        assert device[0] == 2
+    else:
+        assert device == (1, 0)
+    assert a1.x.__dlpack_device__() is device
+
+    # The standard 'stream' keyword of the DLPack protocol is accepted
+    assert a1.x == Float(a1.x.__dlpack__(stream=None))
+
 
 @pytest.mark.parametrize("package", ["drjit.cuda", "drjit.cuda.ad",
                                      "drjit.llvm", "drjit.llvm.ad",